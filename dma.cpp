@@ -0,0 +1,121 @@
+/*
+ * Copyright (c) 2022, Harsh Dave.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ *
+ */
+
+/**
+ * \file
+ *         A very simple implementation of dynamic memory allocation APIs.
+ *         driver_beta is a thin C interface over hheap::beta, all of
+ *         hheap memory itself lives in hheap.hpp.
+ * \author
+ *         Harsh Dave <HarshDave-Sithlord>
+ */
+#include "hheap.hpp"
+#include "utils.h"
+
+hheap::beta_heap hheap::beta;
+
+static bool_t hheap_init(void)
+{
+	return hheap::beta.init();
+}
+
+static void *hheap_alloc(uint32_t size)
+{
+	return hheap::beta.alloc(size);
+}
+
+static void *hheap_calloc(uint32_t count, uint32_t size)
+{
+	return hheap::beta.calloc(count, size);
+}
+
+static bool_t hheap_realloc(void **addr, uint32_t size)
+{
+	return hheap::beta.realloc(addr, size);
+}
+
+static bool_t hheap_free(void *addr)
+{
+	return hheap::beta.free(addr);
+}
+
+static void hheap_flush(void)
+{
+	hheap::beta.flush();
+}
+
+static void hheap_maintenance(void *free_ptr)
+{
+	hheap::beta.maintenance((unsigned char *)free_ptr);
+}
+
+static void hheap_stats(void)
+{
+	hheap::beta.stats();
+}
+
+static void hheap_set_policy(heap_policy policy)
+{
+	hheap::beta.set_policy(policy);
+}
+
+static heap_policy hheap_get_policy(void)
+{
+	return hheap::beta.get_policy();
+}
+
+static bool_t hheap_export_map(int fd)
+{
+	return hheap::beta.export_map(fd);
+}
+
+static void hheap_set_mmap_threshold(uint32_t threshold)
+{
+	hheap::beta.set_mmap_threshold(threshold);
+}
+
+struct hheap_driver driver_beta = {
+	hheap::beta.region(),
+	hheap_init,
+	hheap_alloc,
+	hheap_calloc,
+	hheap_realloc,
+	hheap_free,
+	hheap_flush,
+	hheap_maintenance,
+	hheap_stats,
+	hheap_set_policy,
+	hheap_get_policy,
+	hheap_profiler_set_interval,
+	hheap_profiler_dump,
+	hheap_export_map,
+	hheap_set_mmap_threshold,
+};
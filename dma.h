@@ -46,6 +46,10 @@
 #include "typedef.h"
 #endif
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 /**
  * hheap memory configuration.
  * alignment	: rounds off memory chunk.
@@ -68,8 +72,19 @@
  */
 #define HEAP_SIZE ALIGN(1024*4*1024)
 
+/**
+ * Large object configuration.
+ * mmap_threshold	: requests of this size or more get a mapping of their
+ *                    own instead of a block in hheap memory. Can be changed
+ *                    at runtime through HEAP.set_mmap_threshold().
+ * mmap_slots		: large objects which can be alive at the same time.
+ */
+#define HEAP_MMAP_THRESHOLD (128U * 1024U)
+#define HEAP_MMAP_SLOTS 64U
+
 /**
  * Debug configuration macros.
+ * DEBUG can be overridden from the command line, -DDEBUG=0 silences hheap.
  * WIP
  */
 #define APP_DEBUG 1
@@ -77,66 +92,53 @@
 #define HEAP_ADDRESS_DEBUG 3
 #define HEAP_MEM_SIZE_DEBUG 4
 #define HEAP_3_4_COMBINE 5
+#ifndef DEBUG
 #define DEBUG HEAP_DEBUG_ALL
+#endif
+
+/**
+ * Sampling heap profiler.
+ * When set to 1, hheap_alloc and hheap_free call into heap_profiler.c.
+ * Sampling itself stays off until an interval is set through
+ * HEAP.set_sampling_interval().
+ */
+#define HEAP_PROFILER 1
 
 /**
  * Heap memory policy decides in what manner the memory to be found
  * for a given size.
- * User can opt for first fit, next fit and best fit policy.
- * WIP
+ * User can opt for first fit, next fit and best fit policy, or let
+ * adaptive mode switch between them as the workload changes.
  */
 #define FIRST_FIT 0U
 #define NEXT_FIT 1U
 #define BEST_FIT 2U
+#define ADAPTIVE 3U
 
 /**
- * hheap APIs return status
+ * Adaptive policy configuration.
+ * adapt_window		: allocations observed before policy is re-evaluated.
+ * adapt_probe		: allocations a probe of another policy lasts.
+ * adapt_frag_budget	: fragmentation(%) above which best fit is forced.
+ * adapt_fail_rate	: failed allocations(%) in a window above which best
+ *                    fit is forced, if a large enough free chunk existed.
+ * adapt_explore	: every Nth window probes another policy to keep
+ *                    its score up to date.
+ * adapt_skip		: policies costing more than this many times the
+ *                    cheapest one are not probed.
  */
-#define OK 0U
-#define FAIL 1U
+#define HEAP_ADAPT_WINDOW 256U
+#define HEAP_ADAPT_PROBE 8U
+#define HEAP_ADAPT_FRAG_BUDGET 30U
+#define HEAP_ADAPT_FAIL_RATE 10U
+#define HEAP_ADAPT_EXPLORE 16U
+#define HEAP_ADAPT_SKIP 4U
 
 /**
- * hheap utilities.
- * high_end marks end of hheap memory
- * low_end marks beginning of hheap memory
- */
-#define HEAP_HIGH_END \
-	({\
-		hheap->heap + HEAP_SIZE/sizeof(unsigned int); \
-	})
-
-#define HEAP_LOW_END \
-	({\
-		hheap->heap;\
-	})
-
-/**
- * Once memory chunk is allocated, meta-data of heap needs to be
- * updated since it keeps current status information about heap.
- */
-#define UPDATE_REM_MEM(x) \
-	({\
-		hheap->rem_mem -= x;\
-		if(hheap->rem_mem <= 0)\
-		{\
-			printf("Critical Error\n");\
-		}\
-	})
-
-/**
- * Utility routine to check whether the address falls within
- * valid range of heap memory or not.
+ * hheap APIs return status
  */
-#define VALIDATE_ADDRESS(x) \
-	({\
-		unsigned char ret = FAIL;\
-		if(x >= hheap->heap && x < HEAP_HIGH_END) \
-		{\
-			ret = OK;\
-		}\
-		ret;\
-	})
-
+#define OK 0U
+#define FAIL 1U
 
 #define DMA_SIZE ALIGN(HEAP_SIZE)
 
@@ -153,6 +155,7 @@ typedef enum{
 	heap_first_fit = 0,
 	heap_next_fit,
 	heap_best_fit,
+	heap_adaptive,
 }heap_policy;
 
 /**
@@ -162,6 +165,7 @@ struct hheap_driver{
 	struct heap_memory **heap; /*WIP-#1*/
 	unsigned char (*init_heap)(void);
 	void * (*heap_alloc)(unsigned int size);
+	void * (*heap_calloc)(unsigned int count, unsigned int size);
 	bool_t (*heap_realloc)(void **addr, unsigned int size);
 	unsigned char (*heap_free)(void *addr);
 	void (*heap_flush)(void);
@@ -169,12 +173,18 @@ struct hheap_driver{
 	void (*heap_statistics)(void);
 	void (*set_heap_policy)(heap_policy policy);
 	heap_policy (*get_heap_policy)(void);
+	void (*set_sampling_interval)(uint32_t interval);
+	bool_t (*dump_profile)(int fd);
+	bool_t (*export_heap_map)(int fd);
+	void (*set_mmap_threshold)(uint32_t threshold);
 };
 
-typedef void *(*find_mem_block)(uint32_t size);
-
-struct hheap_driver driver_beta;
+extern struct hheap_driver driver_beta;
 
 #define HEAP driver_beta
 
+#ifdef __cplusplus
+}
+#endif
+
 #endif /* DYNAMIC_MEMORY_ALLOCATION_DMA_H_ */
@@ -0,0 +1,106 @@
+/*
+ * Copyright (c) 2022, Harsh Dave.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ *
+ */
+
+/**
+ * \file
+ *         binary layout of hheap memory map, shared by hheap_export_map and hmap_view
+ * \author
+ *         Harsh Dave <HarshDave-Sithlord>
+ */
+
+#ifndef DYNAMIC_MEMORY_ALLOCATION_HEAP_MAP_H_
+#define DYNAMIC_MEMORY_ALLOCATION_HEAP_MAP_H_
+
+#ifndef HHEAP_TYPEDEF
+#include "typedef.h"
+#endif
+
+/**
+ * A heap map is a stream of snapshots. Every snapshot is one
+ * struct hmap_header followed by struct hmap_record entries and ends
+ * with a record whose state is HMAP_END. All fields are written in
+ * host byte order(little endian on every target we run on).
+ * Snapshots can simply be appended to one file.
+ */
+#define HMAP_MAGIC "HMAP"
+#define HMAP_VERSION 1U
+
+/**
+ * Block states.
+ * free/used	: state bit of block header.
+ * corrupt	: header with size 0 or running past high end of heap,
+ *                covers the rest of heap since walk cannot go on.
+ * mapped	: large object served by a mapping of its own, outside hheap
+ *                memory. offset is 0 and size is the mapping length. These
+ *                records follow the records of hheap memory.
+ * end		: last record of a snapshot, offset holds the bytes walked
+ *                and run holds the number of records before it.
+ */
+#define HMAP_FREE 0U
+#define HMAP_USED 1U
+#define HMAP_CORRUPT 2U
+#define HMAP_MAPPED 3U
+#define HMAP_END 0xFFU
+
+/**
+ * Lifetime classes.
+ * Block headers carry no age yet, so exporter writes unknown.
+ */
+#define HMAP_LIFETIME_UNKNOWN 0U
+
+/**
+ * Records written per write() call while exporting.
+ */
+#define HMAP_BATCH 256U
+
+struct hmap_header{
+	char magic[4];
+	uint16_t version;
+	uint16_t record_size;
+	uint32_t heap_size;
+	uint32_t rem_mem;
+	uint64_t timestamp_ns;
+};
+
+/**
+ * run consecutive blocks of same size and state,
+ * first one starting at offset bytes from low end of heap.
+ */
+struct hmap_record{
+	uint32_t offset;
+	uint32_t size;
+	uint32_t run;
+	uint8_t state;
+	uint8_t lifetime;
+	uint16_t reserved;
+};
+
+#endif /* DYNAMIC_MEMORY_ALLOCATION_HEAP_MAP_H_ */
@@ -0,0 +1,394 @@
+/*
+ * Copyright (c) 2022, Harsh Dave.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ *
+ */
+
+/**
+ * \file
+ *         A sampling heap profiler which attributes hheap memory to call stacks
+ * \author
+ *         Harsh Dave <HarshDave-Sithlord>
+ */
+#include <math.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <execinfo.h>
+#include "dma.h"
+#include "heap_profiler.h"
+
+#define HPROF_OFF ((int64_t)0x7fffffffffffffffL)
+
+/**
+ * One entry per distinct call stack.
+ * live_* counts sampled blocks which are still allocated,
+ * total_* counts every block ever sampled from this stack.
+ */
+struct hprof_stack{
+	uint64_t hash;
+	uint32_t depth;
+	void *pc[HPROF_MAX_DEPTH];
+	uint64_t live_count;
+	uint64_t live_bytes;
+	uint64_t total_count;
+	uint64_t total_bytes;
+};
+
+/**
+ * One entry per sampled block which is still allocated.
+ * addr is the address handed out by hheap_alloc. Entries are kept sorted
+ * by addr: hheap_maintenance shifts a whole address range down by the same
+ * distance, which keeps the order, so only entries within the range have
+ * to be touched.
+ */
+struct hprof_live{
+	void *addr;
+	uint32_t size;
+	uint32_t stack;
+};
+
+int64_t hprof_bytes_until_sample = HPROF_OFF;
+uint32_t hprof_live_count = 0;
+static uint32_t hprof_interval = 0;
+static uint32_t hprof_period = 0;
+static uint32_t hprof_dropped = 0;
+static uint64_t hprof_rng = 88172645463325252UL;
+static struct hprof_stack stacks[HPROF_MAX_STACKS];
+static struct hprof_live live[HPROF_MAX_LIVE];
+
+/**
+ * hprof_next_interval
+ * ARGS:none
+ * Return value: number of bytes to be allocated before the next sample
+ * Description: Draws the gap to the next sample from an exponential
+ * distribution with mean hprof_interval. Sampling allocations at Poisson
+ * distributed byte offsets gives every byte the same chance of being
+ * sampled, whatever the allocation sizes are.
+ */
+static int64_t hprof_next_interval(void)
+{
+	double u;
+	int64_t next;
+
+	hprof_rng ^= hprof_rng << 13;
+	hprof_rng ^= hprof_rng >> 7;
+	hprof_rng ^= hprof_rng << 17;
+	/**
+	 * Top 53 bits of the generator give u in (0, 1].
+	 */
+	u = (double)((hprof_rng >> 11) + 1) / 9007199254740992.0;
+	next = (int64_t)(-log(u) * hprof_interval);
+
+	return (next > 0) ? next : 1;
+}
+
+/**
+ * hprof_live_lower
+ * ARGS:addr
+ * Return value: index of first live sample at or above addr
+ * Description: Binary search over live samples.
+ */
+static uint32_t hprof_live_lower(void *addr)
+{
+	uint32_t low = 0, high = hprof_live_count, mid;
+
+	while(low < high)
+	{
+		mid = (low + high) / 2;
+		if((uint8_t *)live[mid].addr < (uint8_t *)addr)
+		{
+			low = mid + 1;
+		}
+		else
+		{
+			high = mid;
+		}
+	}
+	return low;
+}
+
+static void hprof_live_insert(void *addr, uint32_t size, uint32_t stack)
+{
+	uint32_t at = hprof_live_lower(addr);
+
+	memmove(&live[at + 1], &live[at], (hprof_live_count - at) * sizeof(struct hprof_live));
+	live[at].addr = addr;
+	live[at].size = size;
+	live[at].stack = stack;
+	hprof_live_count++;
+}
+
+static void hprof_live_remove(uint32_t at)
+{
+	stacks[live[at].stack].live_count--;
+	stacks[live[at].stack].live_bytes -= live[at].size;
+	hprof_live_count--;
+	memmove(&live[at], &live[at + 1], (hprof_live_count - at) * sizeof(struct hprof_live));
+}
+
+/**
+ * hprof_find_stack
+ * ARGS:pc(return addresses), depth(number of return addresses)
+ * Return value: index of stack entry, -1 if stack table is full
+ * Description: Looks up the call stack in stack table and adds it
+ * if it was never seen before.
+ */
+static int32_t hprof_find_stack(void **pc, uint32_t depth)
+{
+	uint64_t hash = 14695981039346656037UL;
+	uint32_t slot;
+
+	for(uint32_t i = 0; i < depth; i++)
+	{
+		hash = (hash ^ (uint64_t)pc[i]) * 1099511628211UL;
+	}
+
+	slot = (uint32_t)hash & (HPROF_MAX_STACKS - 1);
+	for(uint32_t i = 0; i < HPROF_MAX_STACKS; i++)
+	{
+		if(stacks[slot].depth == 0)
+		{
+			stacks[slot].hash = hash;
+			stacks[slot].depth = depth;
+			memcpy(stacks[slot].pc, pc, depth * sizeof(void *));
+			return (int32_t)slot;
+		}
+		if(stacks[slot].hash == hash && stacks[slot].depth == depth &&
+				memcmp(stacks[slot].pc, pc, depth * sizeof(void *)) == 0)
+		{
+			return (int32_t)slot;
+		}
+		slot = (slot + 1) & (HPROF_MAX_STACKS - 1);
+	}
+	return -1;
+}
+
+/**
+ * hheap_profiler_sample
+ * ARGS:addr(address handed out by hheap_alloc), size(requested size)
+ * Return value: none
+ * Description: Called through HPROF_ALLOC_HOOK once the sampling counter
+ * runs out. Captures the call stack of the allocation, charges the block
+ * to it and arms the counter for the next sample.
+ */
+void hheap_profiler_sample(void *addr, uint32_t size)
+{
+	void *pc[HPROF_MAX_DEPTH + HPROF_SKIP_FRAMES];
+	int32_t depth, stack;
+
+	if(hprof_interval == 0)
+	{
+		hprof_bytes_until_sample = HPROF_OFF;
+		return;
+	}
+	hprof_bytes_until_sample = hprof_next_interval();
+
+	depth = backtrace(pc, HPROF_MAX_DEPTH + HPROF_SKIP_FRAMES);
+	if(depth <= (int32_t)HPROF_SKIP_FRAMES)
+	{
+		hprof_dropped++;
+		return;
+	}
+
+	stack = hprof_find_stack(pc + HPROF_SKIP_FRAMES, depth - HPROF_SKIP_FRAMES);
+	if(stack < 0 || hprof_live_count == HPROF_MAX_LIVE)
+	{
+		hprof_dropped++;
+		return;
+	}
+
+	hprof_live_insert(addr, size, (uint32_t)stack);
+	stacks[stack].live_count++;
+	stacks[stack].live_bytes += size;
+	stacks[stack].total_count++;
+	stacks[stack].total_bytes += size;
+}
+
+/**
+ * hheap_profiler_release
+ * ARGS:addr(address being freed)
+ * Return value: none
+ * Description: Removes the block from live samples, if it was sampled.
+ */
+void hheap_profiler_release(void *addr)
+{
+	uint32_t at = hprof_live_lower(addr);
+
+	if(at < hprof_live_count && live[at].addr == addr)
+	{
+		hprof_live_remove(at);
+	}
+}
+
+/**
+ * hheap_profiler_relocate
+ * ARGS:low, high(range of addresses which moved), delta(distance moved)
+ * Return value: none
+ * Description: hheap_maintenance slides occupied blocks down over a freed
+ * block. Live samples within the moved range have to follow them or the
+ * later hheap_free of those blocks would never find its sample. The freed
+ * block was released before, so nothing lies in [low - delta, low) and
+ * shifting the range keeps live samples sorted.
+ */
+void hheap_profiler_relocate(void *low, void *high, uint32_t delta)
+{
+	for(uint32_t at = hprof_live_lower(low); at < hprof_live_count && (uint8_t *)live[at].addr < (uint8_t *)high; at++)
+	{
+		live[at].addr = (uint8_t *)live[at].addr - delta;
+	}
+}
+
+/**
+ * hheap_profiler_resize
+ * ARGS:addr(old address), new_addr(address after resize), size(new requested size)
+ * Return value: none
+ * Description: Re-keys the sample of a resized block to its new address
+ * and charges the size difference to the stack it was sampled from.
+ */
+void hheap_profiler_resize(void *addr, void *new_addr, uint32_t size)
+{
+	uint32_t at = hprof_live_lower(addr), stack;
+
+	if(at < hprof_live_count && live[at].addr == addr)
+	{
+		stack = live[at].stack;
+		hprof_live_remove(at);
+		hprof_live_insert(new_addr, size, stack);
+		stacks[stack].live_count++;
+		stacks[stack].live_bytes += size;
+	}
+}
+
+/**
+ * hheap_profiler_reset
+ * ARGS:none
+ * Return value: none
+ * Description: Forgets every live sample, called when hheap memory is
+ * flushed and all blocks are gone at once. Cumulative counts stay.
+ */
+void hheap_profiler_reset(void)
+{
+	for(uint32_t i = 0; i < HPROF_MAX_STACKS; i++)
+	{
+		stacks[i].live_count = 0;
+		stacks[i].live_bytes = 0;
+	}
+	hprof_live_count = 0;
+}
+
+/**
+ * hheap_profiler_set_interval
+ * ARGS:interval(mean bytes between samples, 0 turns sampling off)
+ * Return value: none
+ * Description: Starts, stops or retunes sampling. Samples already taken
+ * stay in the profile; blocks sampled earlier are still tracked until
+ * they are freed.
+ */
+void hheap_profiler_set_interval(uint32_t interval)
+{
+	hprof_interval = interval;
+	if(interval)
+	{
+		hprof_period = interval;
+		hprof_bytes_until_sample = hprof_next_interval();
+	}
+	else
+	{
+		hprof_bytes_until_sample = HPROF_OFF;
+	}
+}
+
+/**
+ * hheap_profiler_dump
+ * ARGS:fd(file descriptor to write profile to)
+ * Return value: ret(OK,FAIL)
+ * Description: Writes live and cumulative samples in legacy heap profile
+ * format(heap_v2), followed by the memory map of the process, so pprof
+ * can symbolize and un-sample it:
+ *   $ pprof --text ./dma heap.prof
+ */
+bool_t hheap_profiler_dump(int fd)
+{
+	uint64_t live_count = 0, live_bytes = 0, total_count = 0, total_bytes = 0;
+	char maps[4096];
+	ssize_t len;
+	int maps_fd;
+
+	if(fd < 0)
+	{
+		return FAIL;
+	}
+
+	for(uint32_t i = 0; i < HPROF_MAX_STACKS; i++)
+	{
+		live_count += stacks[i].live_count;
+		live_bytes += stacks[i].live_bytes;
+		total_count += stacks[i].total_count;
+		total_bytes += stacks[i].total_bytes;
+	}
+
+	if(dprintf(fd, "heap profile: %lu: %lu [%lu: %lu] @ heap_v2/%u\n",
+			live_count, live_bytes, total_count, total_bytes, hprof_period) < 0)
+	{
+		return FAIL;
+	}
+
+	for(uint32_t i = 0; i < HPROF_MAX_STACKS; i++)
+	{
+		if(stacks[i].total_count == 0)
+		{
+			continue;
+		}
+		dprintf(fd, "%lu: %lu [%lu: %lu] @", stacks[i].live_count, stacks[i].live_bytes,
+				stacks[i].total_count, stacks[i].total_bytes);
+		for(uint32_t j = 0; j < stacks[i].depth; j++)
+		{
+			dprintf(fd, " %p", stacks[i].pc[j]);
+		}
+		dprintf(fd, "\n");
+	}
+
+	dprintf(fd, "\nMAPPED_LIBRARIES:\n");
+	maps_fd = open("/proc/self/maps", O_RDONLY);
+	if(maps_fd >= 0)
+	{
+		while((len = read(maps_fd, maps, sizeof(maps))) > 0)
+		{
+			if(write(fd, maps, len) != len)
+			{
+				break;
+			}
+		}
+		close(maps_fd);
+	}
+
+#if DEBUG == HEAP_DEBUG_ALL
+	printf("hprof :: dumped %lu live samples, %u dropped\n", live_count, hprof_dropped);
+#endif
+	return OK;
+}
@@ -0,0 +1,136 @@
+/*
+ * Copyright (c) 2022, Harsh Dave.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ *
+ */
+
+/**
+ * \file
+ *         declarations of sampling heap profiler used by hheap memory
+ * \author
+ *         Harsh Dave <HarshDave-Sithlord>
+ */
+
+#ifndef DYNAMIC_MEMORY_ALLOCATION_HEAP_PROFILER_H_
+#define DYNAMIC_MEMORY_ALLOCATION_HEAP_PROFILER_H_
+
+#ifndef HHEAP_TYPEDEF
+#include "typedef.h"
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Profiler configuration.
+ * default_interval	: mean number of allocated bytes between two samples.
+ * max_depth		: deepest call stack recorded for a sample.
+ * skip_frames		: profiler and allocator frames dropped from every stack,
+ *                    hheap_profiler_sample and the driver entry point
+ *                    (hheap_alloc, hheap_calloc or hheap_realloc) which
+ *                    basic_heap is inlined into.
+ * max_stacks		: distinct call stacks the profiler can attribute memory to.
+ * max_live		: sampled blocks which can be alive at the same time.
+ */
+#define HPROF_DEFAULT_INTERVAL (512U * 1024U)
+#define HPROF_MAX_DEPTH 32U
+#define HPROF_SKIP_FRAMES 2U
+#define HPROF_MAX_STACKS 1024U
+#define HPROF_MAX_LIVE 4096U
+
+/**
+ * Bytes left before the next sample is taken.
+ * While sampling is off it is parked at a value no program can allocate
+ * through, so the alloc hook costs one subtraction and one compare.
+ */
+extern int64_t hprof_bytes_until_sample;
+
+/**
+ * Number of sampled blocks which are still allocated.
+ * free and move hooks are one load and compare while it is zero, otherwise
+ * a binary search over live samples plus the samples which actually moved.
+ */
+extern uint32_t hprof_live_count;
+
+void hheap_profiler_sample(void *addr, uint32_t size);
+void hheap_profiler_release(void *addr);
+void hheap_profiler_relocate(void *low, void *high, uint32_t delta);
+void hheap_profiler_reset(void);
+void hheap_profiler_resize(void *addr, void *new_addr, uint32_t size);
+void hheap_profiler_set_interval(uint32_t interval);
+bool_t hheap_profiler_dump(int fd);
+
+/**
+ * Profiler hooks called from hheap APIs.
+ * alloc hook charges size bytes to the sampling counter and records the
+ * call stack once the counter runs out.
+ * free hook drops the block from live samples if it was ever sampled.
+ * resize hook keeps the sample of a block resized in place or moved
+ * by hheap_realloc.
+ * move hook follows the blocks which hheap_maintenance shifts towards
+ * the low end of heap.
+ */
+#define HPROF_ALLOC_HOOK(addr, size) \
+	({\
+		hprof_bytes_until_sample -= (int64_t)(size);\
+		if(__builtin_expect(hprof_bytes_until_sample < 0, 0))\
+		{\
+			hheap_profiler_sample(addr, size);\
+		}\
+	})
+
+#define HPROF_FREE_HOOK(addr) \
+	({\
+		if(__builtin_expect(hprof_live_count != 0, 0))\
+		{\
+			hheap_profiler_release(addr);\
+		}\
+	})
+
+#define HPROF_RESIZE_HOOK(addr, new_addr, size) \
+	({\
+		if(__builtin_expect(hprof_live_count != 0, 0))\
+		{\
+			hheap_profiler_resize(addr, new_addr, size);\
+		}\
+	})
+
+#define HPROF_MOVE_HOOK(low, high, delta) \
+	({\
+		if(__builtin_expect(hprof_live_count != 0, 0))\
+		{\
+			hheap_profiler_relocate(low, high, delta);\
+		}\
+	})
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DYNAMIC_MEMORY_ALLOCATION_HEAP_PROFILER_H_ */
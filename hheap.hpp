@@ -0,0 +1,1480 @@
+/*
+ * Copyright (c) 2022, Harsh Dave.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ *
+ */
+
+/**
+ * \file
+ *         Compile time specialised hheap memory(header only, C++17).
+ *         driver_beta is one instantiation of basic_heap, see dma.cpp.
+ * \author
+ *         Harsh Dave <HarshDave-Sithlord>
+ */
+
+#ifndef DYNAMIC_MEMORY_ALLOCATION_HHEAP_HPP_
+#define DYNAMIC_MEMORY_ALLOCATION_HHEAP_HPP_
+
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+#include <type_traits>
+#include <unistd.h>
+#include <sys/mman.h>
+#include "dma.h"
+#include "heap_profiler.h"
+#include "heap_map.h"
+
+namespace hheap {
+
+/**
+ * Heap policies.
+ * A policy is a member of basic_heap whose find() is called directly,
+ * so the search is inlined into alloc instead of going through a
+ * function pointer.
+ * find(heap, need)	: header of a free block with room for need bytes
+ *                    plus trailing header, or nullptr.
+ * start(heap)		: called once hheap memory is mapped.
+ * select(heap, policy)	: hheap_set_policy.
+ * get()		: hheap_get_policy.
+ * Fixed policies count nothing, search() takes the probe counter as a
+ * template argument so that counting compiles away for them.
+ */
+struct no_probes{
+	void operator++(int) noexcept
+	{
+	}
+};
+
+template<heap_policy Id>
+struct fixed_policy{
+	static constexpr heap_policy id = Id;
+
+	template<class Heap>
+	void start(Heap &heap) noexcept
+	{
+		heap.cursor() = heap.low_end();
+	}
+
+	template<class Heap>
+	void select(Heap &, heap_policy policy) noexcept
+	{
+		if(policy != Id)
+		{
+			printf("Oops!\n");
+		}
+	}
+
+	heap_policy get(void) const noexcept
+	{
+		return Id;
+	}
+};
+
+/**
+ * first_fit
+ * Walks from low end and returns the first free block large enough.
+ */
+struct first_fit : fixed_policy<heap_first_fit>{
+	template<class Heap, class Probes>
+	static unsigned char *search(Heap &heap, std::uint32_t need, Probes &probes) noexcept
+	{
+		unsigned char *start = heap.low_end();
+		while(start < heap.high_end())
+		{
+			probes++;
+			if(!Heap::used(start) && Heap::size_of(start) > need)
+			{
+				return start;
+			}
+			start += Heap::size_of(start);
+		}
+		return nullptr;
+	}
+
+	template<class Heap>
+	unsigned char *find(Heap &heap, std::uint32_t need) noexcept
+	{
+		no_probes probes;
+		return search(heap, need, probes);
+	}
+};
+
+/**
+ * next_fit
+ * Walks from the block found last time(heap cursor), wraps around at
+ * high end and gives up once it is back where it started.
+ */
+struct next_fit : fixed_policy<heap_next_fit>{
+	template<class Heap, class Probes>
+	static unsigned char *search(Heap &heap, std::uint32_t need, Probes &probes) noexcept
+	{
+		unsigned char *start = heap.cursor();
+		bool_t iterated_flag = 0U;
+		while(!iterated_flag)
+		{
+			probes++;
+			if(!Heap::used(start) && Heap::size_of(start) > need)
+			{
+				heap.cursor() = start;
+				return start;
+			}
+
+			start += Heap::size_of(start);
+
+			if(start == heap.high_end())
+			{
+				start = heap.low_end();
+			}
+
+			if(start == heap.cursor())
+			{
+				iterated_flag = 1U;
+			}
+		}
+		return nullptr;
+	}
+
+	template<class Heap>
+	unsigned char *find(Heap &heap, std::uint32_t need) noexcept
+	{
+		no_probes probes;
+		return search(heap, need, probes);
+	}
+};
+
+/**
+ * best_fit
+ * Walks entire hheap memory and returns the smallest free block large
+ * enough. Stops early on an exact fit.
+ */
+struct best_fit : fixed_policy<heap_best_fit>{
+	template<class Heap, class Probes>
+	static unsigned char *search(Heap &heap, std::uint32_t need, Probes &probes) noexcept
+	{
+		unsigned char *start = heap.low_end();
+		unsigned char *best = nullptr;
+		std::uint32_t chunk, best_size = 0xFFFFFFFFU;
+		while(start < heap.high_end())
+		{
+			probes++;
+			chunk = Heap::size_of(start);
+			if(chunk == 0)
+			{
+				break;
+			}
+			if(!Heap::used(start) && chunk > need && chunk < best_size)
+			{
+				best = start;
+				best_size = chunk;
+				if(chunk == need + Heap::header_width)
+				{
+					break;
+				}
+			}
+			start += chunk;
+		}
+		return best;
+	}
+
+	template<class Heap>
+	unsigned char *find(Heap &heap, std::uint32_t need) noexcept
+	{
+		no_probes probes;
+		return search(heap, need, probes);
+	}
+};
+
+/**
+ * runtime_fit
+ * Policy picked at runtime through hheap_set_policy, what driver_beta
+ * uses. All three searches are inlined into find() behind a switch on
+ * the active policy.
+ * In adaptive mode find() also scores the active policy and switches
+ * it, see adapt().
+ *
+ * fit_probes	: blocks visited since the last window closed.
+ * cost		: smoothed blocks visited per allocation(x16) for every
+ *                concrete policy, 0 while a policy is not measured yet.
+ * settled	: policy to go back to once a probe is over, probing is set
+ *                while a probe runs.
+ * failed_min	: smallest chunk size which could not be found.
+ */
+struct runtime_fit{
+	heap_policy current = heap_next_fit;
+	heap_policy active = heap_next_fit;
+	std::uint32_t fit_probes = 0;
+	std::uint32_t cost[heap_adaptive] = {};
+	std::uint32_t allocs = 0;
+	std::uint32_t failures = 0;
+	std::uint32_t windows = 0;
+	std::uint32_t failed_min = 0xFFFFFFFFU;
+	heap_policy settled = heap_next_fit;
+	heap_policy rotation = heap_first_fit;
+	bool_t probing = 0U;
+
+	template<class Heap>
+	unsigned char *find(Heap &heap, std::uint32_t need) noexcept
+	{
+		unsigned char *block;
+		switch(active)
+		{
+			case heap_first_fit:
+			{
+				block = first_fit::search(heap, need, fit_probes);
+				break;
+			}
+			case heap_best_fit:
+			{
+				block = best_fit::search(heap, need, fit_probes);
+				break;
+			}
+			default:
+			{
+				block = next_fit::search(heap, need, fit_probes);
+				break;
+			}
+		}
+		if(current == heap_adaptive)
+		{
+			adapt(heap, need, block != nullptr);
+		}
+		return block;
+	}
+
+	template<class Heap>
+	void start(Heap &heap) noexcept
+	{
+		use(heap, (current == heap_adaptive) ? active : current);
+	}
+
+	/**
+	 * select
+	 * Takes effect from the very next allocation on a mapped heap.
+	 * Adaptive mode starts out with the active policy and re-measures
+	 * every policy from scratch.
+	 */
+	template<class Heap>
+	void select(Heap &heap, heap_policy policy) noexcept
+	{
+		if(policy > heap_adaptive)
+		{
+			printf("Oops!\n");
+			return;
+		}
+
+		current = policy;
+		std::memset(cost, 0, sizeof(cost));
+		windows = 0;
+		probing = 0U;
+		restart();
+		if(heap.ready())
+		{
+			use(heap, (policy == heap_adaptive) ? active : policy);
+		}
+		else if(policy != heap_adaptive)
+		{
+			active = policy;
+		}
+		settled = active;
+	}
+
+	heap_policy get(void) const noexcept
+	{
+		return current;
+	}
+
+private:
+	/**
+	 * use
+	 * Makes a concrete policy the active one. Switching to next fit
+	 * rewinds the cursor to low end.
+	 */
+	template<class Heap>
+	void use(Heap &heap, heap_policy policy) noexcept
+	{
+		switch(policy)
+		{
+			case heap_next_fit:
+			{
+				heap.cursor() = heap.low_end();
+				break;
+			}
+			case heap_first_fit:
+			case heap_best_fit:
+			{
+				break;
+			}
+			default:
+			{
+				printf("Oops!\n");
+				return;
+			}
+		}
+		active = policy;
+	}
+
+	void restart(void) noexcept
+	{
+		allocs = 0;
+		failures = 0;
+		failed_min = 0xFFFFFFFFU;
+		fit_probes = 0;
+	}
+
+	heap_policy cheapest(void) const noexcept
+	{
+		heap_policy best = settled;
+		for(int policy = heap_first_fit; policy < heap_adaptive; policy++)
+		{
+			if(cost[policy] && (!cost[best] || cost[policy] < cost[best]))
+			{
+				best = (heap_policy)policy;
+			}
+		}
+		return best;
+	}
+
+	/**
+	 * candidate
+	 * Rotates through every policy other than the active one. A policy
+	 * which has not been measured is always probed; one whose last cost
+	 * is more than HEAP_ADAPT_SKIP times the cheapest cost is skipped.
+	 * Returns active policy if none is worth a probe.
+	 */
+	heap_policy candidate(void) noexcept
+	{
+		std::uint32_t best = cost[cheapest()];
+		heap_policy next;
+
+		for(std::uint32_t i = 0; i < heap_adaptive; i++)
+		{
+			next = rotation;
+			rotation = (heap_policy)((rotation + 1) % heap_adaptive);
+			if(next == active)
+			{
+				continue;
+			}
+			if(cost[next] == 0 || cost[next] <= best * HEAP_ADAPT_SKIP)
+			{
+				return next;
+			}
+		}
+		return active;
+	}
+
+	/**
+	 * adapt
+	 * Every HEAP_ADAPT_WINDOW allocations it scores the active policy by
+	 * blocks visited per allocation and then picks the policy for the
+	 * next window:
+	 * - best fit when more than HEAP_ADAPT_FAIL_RATE% of allocations
+	 *   failed while a free chunk large enough for them existed, or when
+	 *   fragmentation went over HEAP_ADAPT_FRAG_BUDGET. A heap which is
+	 *   simply full fails under every policy and is left alone.
+	 *   Fragmentation is measured in windows with failures and every
+	 *   HEAP_ADAPT_EXPLORE windows.
+	 * - a short probe of HEAP_ADAPT_PROBE allocations with another policy,
+	 *   while some policy is not measured yet and every HEAP_ADAPT_EXPLORE
+	 *   windows after that. See candidate().
+	 * - otherwise the cheapest measured policy.
+	 * When the active policy suddenly costs HEAP_ADAPT_SKIP times more than
+	 * it used to, the workload changed and every other policy is measured
+	 * again.
+	 */
+	template<class Heap>
+	void adapt(Heap &heap, std::uint32_t size, bool found) noexcept
+	{
+		heap_policy next;
+		std::uint32_t window, frag, largest;
+
+		allocs++;
+		if(!found)
+		{
+			failures++;
+			if(size < failed_min)
+			{
+				failed_min = size;
+			}
+		}
+		if(allocs < (probing ? HEAP_ADAPT_PROBE : HEAP_ADAPT_WINDOW))
+		{
+			return;
+		}
+
+		window = (fit_probes * 16U) / allocs;
+		if(window == 0)
+		{
+			window = 1;
+		}
+
+		if(probing)
+		{
+			cost[active] = window;
+			probing = 0U;
+			next = cheapest();
+#if DEBUG == HEAP_DEBUG_ALL
+			printf("hadapt :: probe of policy %d cost %u :: policy -> %d\n", active, window, next);
+#endif
+			settled = next;
+			use(heap, next);
+			restart();
+			return;
+		}
+
+		if(cost[active] && window > cost[active] * HEAP_ADAPT_SKIP)
+		{
+			std::memset(cost, 0, sizeof(cost));
+		}
+		cost[active] = cost[active] ? (cost[active] * 3U + window) / 4U : window;
+		windows++;
+		/* walking the heap costs as much as a first fit search, do it only when needed */
+		frag = 0;
+		largest = 0;
+		if(failures || windows % HEAP_ADAPT_EXPLORE == 0)
+		{
+			frag = heap.fragmentation(&largest);
+		}
+		next = cheapest();
+
+		if((failures * 100U > allocs * HEAP_ADAPT_FAIL_RATE && largest > failed_min) ||
+				frag > HEAP_ADAPT_FRAG_BUDGET)
+		{
+			next = heap_best_fit;
+		}
+		else
+		{
+			bool unmeasured = false;
+			for(int policy = heap_first_fit; policy < heap_adaptive; policy++)
+			{
+				unmeasured |= (cost[policy] == 0);
+			}
+			if(unmeasured || windows % HEAP_ADAPT_EXPLORE == 0)
+			{
+				heap_policy probe = candidate();
+				if(probe != active)
+				{
+					settled = active;
+					probing = 1U;
+					next = probe;
+				}
+			}
+		}
+
+#if DEBUG == HEAP_DEBUG_ALL
+		printf("hadapt :: cost %u frag %u%% failures %u :: policy %d -> %d%s\n", window, frag, failures,
+				active, next, probing ? "(probe)" : "");
+#endif
+		if(!probing)
+		{
+			settled = next;
+		}
+		if(next != active)
+		{
+			use(heap, next);
+		}
+		restart();
+	}
+};
+
+/**
+ * Block size classes.
+ * block<Granule>(need) turns an aligned block size(header included) into
+ * the block size actually carved out.
+ * exact_size		: no rounding, what a compacting heap wants since
+ *                    freed blocks never stay around to be reused.
+ * size_classes		: up to 8 granules every block size is its own class.
+ *                    Above that every power of two p is split into 4
+ *                    classes of p/4 steps, which bounds the rounding waste
+ *                    to 25%. Table is built at compile time.
+ */
+struct exact_size{
+	template<std::uint32_t Granule>
+	static constexpr std::uint32_t block(std::uint32_t need) noexcept
+	{
+		return need;
+	}
+};
+
+template<std::uint32_t Granule, std::uint32_t Limit>
+struct size_class_table{
+	std::uint32_t block[Limit / Granule + 1];
+};
+
+template<std::uint32_t Granule, std::uint32_t Limit>
+constexpr size_class_table<Granule, Limit> make_size_classes() noexcept
+{
+	size_class_table<Granule, Limit> table{};
+	for(std::uint32_t g = 0; g <= Limit / Granule; g++)
+	{
+		std::uint32_t size = g * Granule, p = Granule;
+		if(size <= 8 * Granule)
+		{
+			table.block[g] = size;
+			continue;
+		}
+		while(p * 2 <= size)
+		{
+			p *= 2;
+		}
+		table.block[g] = (size + p / 4 - 1) & ~(p / 4 - 1);
+	}
+	return table;
+}
+
+template<std::uint32_t Granule, std::uint32_t Limit>
+inline constexpr size_class_table<Granule, Limit> size_class_v = make_size_classes<Granule, Limit>();
+
+template<std::uint32_t Limit = 4096U>
+struct size_classes{
+	template<std::uint32_t Granule>
+	static constexpr std::uint32_t block(std::uint32_t need) noexcept
+	{
+		static_assert(Limit % Granule == 0, "alignment too large for size classes");
+		return (need <= Limit) ? size_class_v<Granule, Limit>.block[need / Granule] : need;
+	}
+};
+
+/**
+ * Spot checks of the table: exact up to 8 granules, then p/4 steps.
+ */
+static_assert(size_class_v<4, 4096>.block[8] == 32, "32 bytes is an exact class");
+static_assert(size_class_v<4, 4096>.block[9] == 40, "36 bytes rounds to 40(p = 32)");
+static_assert(size_class_v<4, 4096>.block[25] == 112, "100 bytes rounds to 112(p = 64)");
+static_assert(size_class_v<4, 4096>.block[1023] == 4096, "4092 bytes rounds to 4096(p = 2048)");
+static_assert(size_class_v<8, 4096>.block[9] == 80, "72 bytes rounds to 80(p = 64)");
+static_assert(size_classes<>::block<4>(8192) == 8192, "blocks above limit are not rounded");
+
+/**
+ * hmap_write
+ * ARGS:fd, buf, len(bytes to be written)
+ * Return value: ret(OK,FAIL)
+ * Description: write() until whole buffer reaches fd.
+ */
+inline bool_t hmap_write(int fd, const void *buf, size_t len)
+{
+	const std::uint8_t *ptr = (const std::uint8_t *)buf;
+	ssize_t done;
+
+	while(len > 0)
+	{
+		done = write(fd, ptr, len);
+		if(done <= 0)
+		{
+			return FAIL;
+		}
+		ptr += done;
+		len -= done;
+	}
+	return OK;
+}
+
+/**
+ * hmap_flush_batch
+ * ARGS:fd, records(batch), count(records in batch)
+ * Return value: ret(OK,FAIL)
+ * Description: Writes the batch out once it is full, so there is
+ * room for one more record.
+ */
+inline bool_t hmap_flush_batch(int fd, struct hmap_record *records, std::uint32_t *count)
+{
+	if(*count < HMAP_BATCH)
+	{
+		return OK;
+	}
+	if(hmap_write(fd, records, HMAP_BATCH * sizeof(struct hmap_record)) != OK)
+	{
+		return FAIL;
+	}
+	std::memset(records, 0, HMAP_BATCH * sizeof(struct hmap_record));
+	*count = 0;
+	return OK;
+}
+
+/**
+ * basic_heap
+ * hheap memory with capacity, alignment, header width, policy and size
+ * classes fixed at compile time, so every size computation folds into
+ * constants and the policy search is inlined into alloc.
+ * Memory is mapped on init(struct heap_memory followed by Capacity bytes).
+ * Every block starts with a header word holding block size | 1 while
+ * occupied, and an allocation leaves a trailing header(remaining memory)
+ * behind it. Free compacts occupied blocks above the freed one down over
+ * it(maintenance), which moves the buffers handed out for them.
+ * Requests of mmap threshold or more get a mapping of their own.
+ * alloc, calloc and realloc are always inlined into their caller, so a
+ * sampled stack holds exactly one allocator frame(the driver entry point,
+ * see HPROF_SKIP_FRAMES) at every optimization level.
+ */
+template<std::uint32_t Capacity, std::uint32_t Alignment = ALIGNMENT,
+		std::uint32_t HeaderWidth = HEADER_SIZE, class Policy = runtime_fit, class Classes = exact_size>
+class basic_heap{
+	static_assert((Alignment & (Alignment - 1)) == 0, "alignment must be a power of two");
+	static_assert(HeaderWidth == 4 || HeaderWidth == 8, "header is a 32 or 64 bit word");
+
+	using header_type = typename std::conditional<HeaderWidth == 8, std::uint64_t, std::uint32_t>::type;
+
+	/**
+	 * Registry of large objects.
+	 * Every large object is a mapping of its own which starts with
+	 * a regular header(mapping length | 1) followed by the buffer.
+	 */
+	struct large_object{
+		unsigned char *header;
+		size_t length;
+	};
+
+public:
+	/**
+	 * granule	: every block size is a multiple of it, keeps both
+	 *            payloads and headers aligned.
+	 * lead		: offset of first header from heap_memory::heap, so that
+	 *            payloads land on Alignment boundaries of the page aligned
+	 *            mapping.
+	 */
+	static constexpr std::uint32_t granule = (Alignment > HeaderWidth) ? Alignment : HeaderWidth;
+	static constexpr std::uint32_t lead = (granule - (sizeof(struct heap_memory) + HeaderWidth) % granule) % granule;
+	static constexpr std::uint32_t header_width = HeaderWidth;
+	static constexpr std::uint32_t capacity = Capacity;
+	static constexpr std::uint32_t large_slots = HEAP_MMAP_SLOTS;
+
+	static_assert(Capacity % granule == 0, "capacity must be a multiple of alignment");
+	static_assert(Capacity >= 2 * granule && Capacity < 0x80000000U, "capacity out of range");
+
+	constexpr basic_heap() noexcept = default;
+	basic_heap(const basic_heap &) = delete;
+	basic_heap &operator=(const basic_heap &) = delete;
+
+	static constexpr std::uint32_t align_up(std::uint32_t size) noexcept
+	{
+		return (size + granule - 1) & ~(granule - 1);
+	}
+
+	/**
+	 * block_for
+	 * Block size(header included) handed out for a request of size bytes.
+	 */
+	static constexpr std::uint32_t block_for(std::uint32_t size) noexcept
+	{
+		return Classes::template block<granule>(align_up(size + HeaderWidth));
+	}
+
+	static std::uint32_t size_of(const unsigned char *block) noexcept
+	{
+		return (std::uint32_t)(read(block) & ~(header_type)1);
+	}
+
+	static bool used(const unsigned char *block) noexcept
+	{
+		return read(block) & 1;
+	}
+
+	bool ready(void) const noexcept
+	{
+		return mem != nullptr;
+	}
+
+	unsigned char *low_end(void) const noexcept
+	{
+		return (unsigned char *)mem->heap + lead;
+	}
+
+	unsigned char *high_end(void) const noexcept
+	{
+		return (unsigned char *)mem->heap + lead + Capacity;
+	}
+
+	unsigned char *&cursor(void) noexcept
+	{
+		return tracker;
+	}
+
+	/**
+	 * region
+	 * Address of mem, for hheap_driver::heap. constexpr so that a driver
+	 * table naming a static basic_heap is initialized at compile time.
+	 */
+	constexpr struct heap_memory **region(void) noexcept
+	{
+		return &mem;
+	}
+
+	/**
+	 * init
+	 * Return value: ret(OK,FAIL)
+	 * Description: Maps Capacity bytes of hheap memory plus heap meta data.
+	 * Anonymous mappings are zero filled by the kernel page by page on
+	 * first touch, so the heap is never cleared up front and pages which
+	 * are never used are never paid for.
+	 * Sets up remaining memory, total memory and the very first header.
+	 */
+	bool_t init(void) noexcept
+	{
+		bool_t ret = FAIL;
+		void *region = mmap(NULL, sizeof(struct heap_memory) + lead + Capacity,
+				PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		if(region != MAP_FAILED)
+		{
+			mem = (struct heap_memory *)region;
+			fresh_mark = low_end();
+			touch(low_end() + HeaderWidth);
+			mem->rem_mem = Capacity;
+			mem->total_mem = Capacity;
+			write(low_end(), Capacity);
+			policy.start(*this);
+
+#if DEBUG == HEAP_DEBUG_ALL
+			printf("hheap memory is initialized[%d]\n", Capacity);
+#endif
+			ret = OK;
+		}
+		return ret;
+	}
+
+	/**
+	 * alloc
+	 * ARGS:size
+	 * Return value: address at which allocated buffer starts
+	 * Description: allocates the memory buffer of requested size. Rounds up
+	 * size + HeaderWidth to append a header to hold meta information
+	 * regarding allocated buffer, such as size of buffer and status of
+	 * it(avail or occupied).
+	 */
+	__attribute__((always_inline)) void *alloc(std::uint32_t size) noexcept
+	{
+		unsigned char *header = nullptr;
+		std::uint32_t total_size = block_for(size);
+
+#if (DEBUG == HEAP_MEM_SIZE_DEBUG) || (DEBUG == HEAP_DEBUG_ALL)
+		printf("hmalloc :: total size needed is :: %d\n", total_size);
+#endif
+		/**
+		 * Large requests are served by a mapping of their own, so they
+		 * neither fragment hheap memory nor fail for want of a big enough
+		 * chunk. If no mapping can be had, fall back to hheap memory.
+		 */
+		if(size >= mmap_threshold && (header = large_map(size)) != nullptr)
+		{
+#if HEAP_PROFILER
+			HPROF_ALLOC_HOOK(header, size);
+#endif
+			return header;
+		}
+
+		header = policy.find(*this, total_size);
+		if(header)
+		{
+			write(header, total_size | 1);
+			/**
+			 * update heap stats. Since a chunk is allocated
+			 * we need the book keeping for available memory
+			 */
+			update_rem_mem(total_size);
+			touch(header + total_size + HeaderWidth);
+			write(header + total_size, mem->rem_mem);
+
+#if (DEBUG == HEAP_ADDRESS_DEBUG) || (DEBUG == HEAP_DEBUG_ALL)
+			printf("hmalloc :: Setting header %p[%d]\n", header, (std::uint32_t)read(header));
+#endif
+			header += HeaderWidth;
+#if HEAP_PROFILER
+			HPROF_ALLOC_HOOK(header, size);
+#endif
+		}
+		else
+		{
+			printf("hmalloc :: Error finding chunk\n");
+		}
+
+		return header;
+	}
+
+	/**
+	 * calloc
+	 * ARGS:count(number of elements), size(size of each element)
+	 * Return value: address at which allocated and zeroed buffer starts
+	 * Description: Only the part of buffer which lies below fresh_mark can
+	 * hold old data, the rest is still untouched zero pages and is left
+	 * as it is. Large objects are fresh mappings and never need clearing.
+	 */
+	__attribute__((always_inline)) void *calloc(std::uint32_t count, std::uint32_t size) noexcept
+	{
+		unsigned char *buffer = nullptr;
+		unsigned char *mark = fresh_mark;
+		std::uint64_t total = (std::uint64_t)count * size;
+
+		if(total > 0xFFFFFFFFUL - (granule + HeaderWidth))
+		{
+			printf("hcalloc :: Size overflow\n");
+			return nullptr;
+		}
+
+		buffer = (unsigned char *)alloc((std::uint32_t)total);
+		if(buffer && buffer >= low_end() && buffer < mark)
+		{
+			std::memset(buffer, 0, ((buffer + total) < mark) ? total : (std::uint64_t)(mark - buffer));
+		}
+
+		return buffer;
+	}
+
+	/**
+	 * free
+	 * ARGS:address of buffer to be freed.
+	 * Return value: ret (OK, FAIL)
+	 * Description: checks the given address is valid or not(whether it
+	 * is within the range of heap memory). If address is valid, it will mark
+	 * its status as available memory block in its header.
+	 * Finally it calls maintenance to align all the occupied buffers at side
+	 * of heap and all the available buffers at the other side of heap.
+	 */
+	bool_t free(void *addr) noexcept
+	{
+		bool_t ret = FAIL;
+		if(addr)
+		{
+			unsigned char *header = (unsigned char *)addr - HeaderWidth;
+
+#if (DEBUG == HEAP_DEBUG_ALL) || (DEBUG == HEAP_ADDRESS_DEBUG)
+			printf("hfree :: Checking address %p and %p -- [%p][%p]\n", header, addr, low_end(), high_end());
+#endif
+			if(validate(header) == OK)
+			{
+#if (DEBUG == HEAP_DEBUG_ALL) || (DEBUG == HEAP_ADDRESS_DEBUG)
+				printf("hfree :: Address is valid :: %p[%d]\n", header, (std::uint32_t)read(header));
+				printf("hfree :: Freeing the memory\n");
+#endif
+#if HEAP_PROFILER
+				HPROF_FREE_HOOK(addr);
+#endif
+				if(header < low_end() || header >= high_end())
+				{
+					/**
+					 * Large object, its mapping is simply dropped and
+					 * hheap memory needs no maintenance.
+					 */
+					return large_unmap(large_find(header));
+				}
+				write(header, size_of(header));
+				update_rem_mem(-size_of(header));
+				ret = OK;
+				maintenance(header);
+			}
+		}
+		else
+		{
+			printf("NULL Address\n");
+		}
+
+		return ret;
+	}
+
+	__attribute__((always_inline)) bool_t realloc(void **addr, std::uint32_t size) noexcept
+	{
+		bool_t ret = FAIL;
+
+		if(*addr)
+		{
+			int32_t slot = large_find((unsigned char *)*addr - HeaderWidth);
+			if(slot >= 0)
+			{
+				return large_remap(addr, size, slot);
+			}
+
+			unsigned char *current_header = (unsigned char *)*addr - HeaderWidth;
+			unsigned char *new_header = nullptr;
+			int32_t diff = (int32_t)block_for(size) - (int32_t)size_of(current_header), current_size = size_of(current_header);
+			unsigned char *next_header = ((unsigned char *)*addr + current_size) - HeaderWidth;
+
+			/**
+			 * Last block of heap(its trailing header still holds remaining
+			 * memory) is resized in place, as long as the free block above
+			 * it keeps room for the trailing header.
+			 */
+			if((size < mmap_threshold) && (read(next_header) == mem->rem_mem) && (diff < 0 || mem->rem_mem > (std::uint32_t)diff))
+			{
+				current_size += diff;
+				update_rem_mem(diff);
+				touch(current_header + current_size + HeaderWidth);
+				write(current_header, current_size | 1);
+				write(current_header + current_size, mem->rem_mem);
+#if HEAP_PROFILER
+				HPROF_RESIZE_HOOK(*addr, *addr, size);
+#endif
+				ret = OK;
+			}
+			else
+			{
+				new_header = (unsigned char *)alloc(size);
+				if(new_header)
+				{
+					std::memset(new_header, '@', size);
+					std::memcpy(new_header, *addr, ((std::uint32_t)(current_size - HeaderWidth) < size) ? (std::uint32_t)(current_size - HeaderWidth) : size);
+					free(*addr);
+				}
+				ret = OK;
+			}
+
+			if(new_header && large_find(new_header - HeaderWidth) >= 0)
+			{
+				/**
+				 * maintenance never moves large objects.
+				 */
+				*addr = new_header;
+			}
+			else if(new_header)
+			{
+				*addr = new_header - current_size;
+			}
+		}
+
+		return ret;
+	}
+
+	/**
+	 * flush
+	 * Description: Clears the content of entire heap memory except the only
+	 * header. Pages are handed back to the kernel instead of being cleared,
+	 * they come back as zero pages when touched again. Large objects are
+	 * unmapped too, every buffer handed out before the flush is gone.
+	 */
+	void flush(void) noexcept
+	{
+		for(std::uint32_t i = 0; i < large_slots && large_count; i++)
+		{
+			if(large[i].header)
+			{
+				large_unmap((int32_t)i);
+			}
+		}
+
+		if(madvise(mem, sizeof(struct heap_memory) + lead + Capacity, MADV_DONTNEED) != 0)
+		{
+			/**
+			 * Nothing above fresh_mark was written, so clearing below it
+			 * is enough.
+			 */
+			std::memset(low_end(), 0, fresh_mark - low_end());
+		}
+		fresh_mark = low_end();
+		touch(low_end() + HeaderWidth);
+		mem->total_mem = Capacity;
+		mem->rem_mem = Capacity;
+		write(low_end(), Capacity);
+		tracker = low_end();
+#if HEAP_PROFILER
+		hheap_profiler_reset();
+#endif
+	}
+
+	/**
+	 * maintenance
+	 * ARGS:free_ptr(header of block just freed)
+	 * Description: Slides the occupied blocks following the freed one down
+	 * over it, trailing header of the last one included, so that all free
+	 * memory ends up in one block at the high end. The trailing header still
+	 * holds remaining memory as of the last alloc, so it is rewritten once
+	 * the blocks have moved, and the next fit cursor follows its block.
+	 */
+	void maintenance(unsigned char *free_ptr) noexcept
+	{
+		std::uint32_t delta = size_of(free_ptr);
+		unsigned char *ptr = free_ptr + delta;
+		unsigned char *nptr = free_ptr + delta;
+		unsigned char *src = free_ptr;
+		unsigned char *high_end_ = nullptr;
+		unsigned char *tail = free_ptr;
+		std::uint32_t count = 0;
+		while(ptr < high_end())
+		{
+			if(used(ptr))
+			{
+				count++;
+				ptr += size_of(ptr);
+			}
+			else
+			{
+				break;
+			}
+		}
+
+#if HEAP_PROFILER
+		/**
+		 * Occupied blocks between nptr and ptr slide down by the size of
+		 * freed block, sampled ones among them have to be moved too.
+		 */
+		HPROF_MOVE_HOOK(nptr, ptr, delta);
+#endif
+		if(count > 0)
+		{
+			tail = ptr - delta;
+		}
+		if(tracker >= ptr)
+		{
+			tracker = tail;
+		}
+		else if(tracker > free_ptr)
+		{
+			tracker -= delta;
+		}
+		while(count > 0)
+		{
+			high_end_ = nptr + size_of(nptr);
+			if(count == 1)
+				high_end_ += HeaderWidth;
+			while(nptr < high_end_)
+			{
+				*src++ = *nptr;
+				*nptr ^= *nptr;
+				nptr++;
+			}
+			count--;
+		}
+		/**
+		 * Freed block and everything above the last occupied block is
+		 * one free block now.
+		 */
+		if(tail < high_end())
+		{
+			write(tail, mem->rem_mem);
+		}
+
+#if DEBUG == HEAP_DEBUG_ALL
+		show();
+#endif
+	}
+
+	/**
+	 * stats
+	 * Description: Dumps hheap memory's active blocks
+	 * and its corresponding size.
+	 */
+	void stats(void) const noexcept
+	{
+		unsigned char *ptr = low_end();
+		while(ptr < high_end())
+		{
+			if(used(ptr))
+			{
+				ptr += size_of(ptr);
+			}
+			else
+			{
+				break;
+			}
+		}
+	}
+
+	void show(void) const noexcept
+	{
+		unsigned char *header = low_end();
+		unsigned char *buffer = header + HeaderWidth;
+		std::uint32_t upto = 0;
+		while(header < high_end() && used(header))
+		{
+			{
+				printf("HEADER :: [%p][%d]\n", header, (std::uint32_t)read(header));
+				printf("Buffer :: \n");
+				upto = size_of(header) - HeaderWidth;
+				buffer = header + HeaderWidth;
+
+				for(std::uint32_t i = 0; i < upto; i++)
+				{
+					if(i%100==0)
+						printf("\n");
+					printf("%c ", buffer[i]);
+				}
+				printf("\n");
+			}
+			header += size_of(header);
+		}
+		printf("\n");
+	}
+
+	/**
+	 * fragmentation
+	 * ARGS:largest(returns size of largest free chunk)
+	 * Return value: percentage of free memory which cannot be handed out as one chunk
+	 * Description: Walks block headers and compares largest free chunk
+	 * with total free memory.
+	 */
+	std::uint32_t fragmentation(std::uint32_t *largest) const noexcept
+	{
+		unsigned char *start = low_end();
+		std::uint64_t free_total = 0;
+		std::uint32_t chunk;
+		*largest = 0;
+		while(start < high_end())
+		{
+			chunk = size_of(start);
+			if(chunk == 0)
+			{
+				break;
+			}
+			if(!used(start))
+			{
+				free_total += chunk;
+				if(chunk > *largest)
+				{
+					*largest = chunk;
+				}
+			}
+			start += chunk;
+		}
+		return free_total ? (std::uint32_t)(100 - (*largest * 100UL) / free_total) : 0;
+	}
+
+	/**
+	 * export_map
+	 * ARGS:fd(file descriptor to stream heap map to)
+	 * Return value: ret(OK,FAIL)
+	 * Description: Walks block headers from low end to high end and streams
+	 * one snapshot of heap map(see heap_map.h) to fd. Consecutive blocks of
+	 * same size and state are folded into one record. Only headers are read,
+	 * payloads are never touched, and records go out in batches of
+	 * HMAP_BATCH so the walk costs one pass over the headers.
+	 * Render it offline with:
+	 *   $ ./hmap_view heap.map
+	 */
+	bool_t export_map(int fd) const noexcept
+	{
+		struct hmap_header map_header;
+		struct hmap_record records[HMAP_BATCH];
+		struct timespec now;
+		unsigned char *start, *end;
+		std::uint32_t count = 0, total = 0, walked, size;
+		std::uint8_t state;
+
+		if(fd < 0 || !mem)
+		{
+			return FAIL;
+		}
+		start = low_end();
+		end = high_end();
+
+		clock_gettime(CLOCK_REALTIME, &now);
+		std::memset(&map_header, 0, sizeof(map_header));
+		std::memcpy(map_header.magic, HMAP_MAGIC, sizeof(map_header.magic));
+		map_header.version = HMAP_VERSION;
+		map_header.record_size = sizeof(struct hmap_record);
+		map_header.heap_size = Capacity;
+		map_header.rem_mem = mem->rem_mem;
+		map_header.timestamp_ns = (std::uint64_t)now.tv_sec * 1000000000UL + now.tv_nsec;
+		if(hmap_write(fd, &map_header, sizeof(map_header)) != OK)
+		{
+			return FAIL;
+		}
+
+		std::memset(records, 0, sizeof(records));
+		while(start < end)
+		{
+			size = size_of(start);
+			state = used(start) ? HMAP_USED : HMAP_FREE;
+			if(size == 0 || size > (std::uint32_t)(end - start))
+			{
+				/**
+				 * Header does not describe a block, nothing beyond
+				 * it can be trusted.
+				 */
+				size = (std::uint32_t)(end - start);
+				state = HMAP_CORRUPT;
+			}
+
+			if(count > 0 && records[count - 1].state == state && records[count - 1].size == size)
+			{
+				records[count - 1].run++;
+			}
+			else
+			{
+				if(hmap_flush_batch(fd, records, &count) != OK)
+				{
+					return FAIL;
+				}
+				records[count].offset = (std::uint32_t)(start - low_end());
+				records[count].size = size;
+				records[count].run = 1;
+				records[count].state = state;
+				records[count].lifetime = HMAP_LIFETIME_UNKNOWN;
+				count++;
+				total++;
+			}
+			start += size;
+		}
+		walked = (std::uint32_t)(start - low_end());
+
+		/**
+		 * Large objects live outside hheap memory, each one is reported
+		 * after the heap walk as a record of its own.
+		 */
+		for(std::uint32_t i = 0; i < large_slots && large_count; i++)
+		{
+			if(large[i].header == nullptr)
+			{
+				continue;
+			}
+			if(hmap_flush_batch(fd, records, &count) != OK)
+			{
+				return FAIL;
+			}
+			records[count].size = (std::uint32_t)large[i].length;
+			records[count].run = 1;
+			records[count].state = HMAP_MAPPED;
+			records[count].lifetime = HMAP_LIFETIME_UNKNOWN;
+			count++;
+			total++;
+		}
+
+		if(hmap_flush_batch(fd, records, &count) != OK)
+		{
+			return FAIL;
+		}
+		records[count].offset = walked;
+		records[count].run = total;
+		records[count].state = HMAP_END;
+		count++;
+
+		return hmap_write(fd, records, count * sizeof(struct hmap_record));
+	}
+
+	void set_policy(heap_policy id) noexcept
+	{
+		policy.select(*this, id);
+	}
+
+	heap_policy get_policy(void) const noexcept
+	{
+		return policy.get();
+	}
+
+	/**
+	 * set_mmap_threshold
+	 * ARGS:threshold(smallest request served by a mapping of its own, 0 turns it off)
+	 */
+	void set_mmap_threshold(std::uint32_t threshold) noexcept
+	{
+		mmap_threshold = threshold ? threshold : 0xFFFFFFFFU;
+	}
+
+	/**
+	 * large_find
+	 * ARGS:header(header address of a buffer)
+	 * Return value: slot of large object registry, -1 if header is not a large object
+	 */
+	int32_t large_find(const void *header) const noexcept
+	{
+		if(large_count == 0)
+		{
+			return -1;
+		}
+
+		for(std::uint32_t i = 0; i < large_slots; i++)
+		{
+			if(large[i].header == header)
+			{
+				return (int32_t)i;
+			}
+		}
+		return -1;
+	}
+
+private:
+	static header_type read(const unsigned char *block) noexcept
+	{
+		header_type header;
+		std::memcpy(&header, block, sizeof(header));
+		return header;
+	}
+
+	static void write(unsigned char *block, header_type header) noexcept
+	{
+		std::memcpy(block, &header, sizeof(header));
+	}
+
+	/**
+	 * touch
+	 * ARGS:end(first byte past the range about to be written)
+	 * Description: Moves fresh_mark above a range which is going to be
+	 * written. Every write into hheap memory that can land above the mark
+	 * has to go through here, otherwise calloc would hand out dirty
+	 * memory without clearing it.
+	 */
+	void touch(unsigned char *end) noexcept
+	{
+		if(end > fresh_mark)
+		{
+			fresh_mark = end;
+		}
+	}
+
+	/**
+	 * Once memory chunk is allocated, meta-data of heap needs to be
+	 * updated since it keeps current status information about heap.
+	 */
+	void update_rem_mem(std::uint32_t size) noexcept
+	{
+		mem->rem_mem -= size;
+		if(mem->rem_mem <= 0)
+		{
+			printf("Critical Error\n");
+		}
+	}
+
+	/**
+	 * Checks whether the header falls within hheap memory. Headers of
+	 * large objects live outside hheap memory, they are valid as long as
+	 * large object registry knows them.
+	 */
+	bool_t validate(const unsigned char *header) const noexcept
+	{
+		return ((header >= low_end() && header < high_end()) || large_find(header) >= 0) ? OK : FAIL;
+	}
+
+	static size_t large_length(std::uint32_t size) noexcept
+	{
+		size_t page = (size_t)sysconf(_SC_PAGESIZE);
+		return ((size_t)size + HeaderWidth + page - 1) & ~(page - 1);
+	}
+
+	/**
+	 * large_map
+	 * ARGS:size
+	 * Return value: address at which allocated buffer starts, nullptr on failure
+	 * Description: Maps a buffer of given size outside hheap memory and
+	 * records it in large object registry.
+	 */
+	unsigned char *large_map(std::uint32_t size) noexcept
+	{
+		size_t length = large_length(size);
+		void *header;
+		std::uint32_t slot;
+
+		if(large_count == large_slots || length > 0x7FFFFFFFUL)
+		{
+			return nullptr;
+		}
+
+		header = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		if(header == MAP_FAILED)
+		{
+			return nullptr;
+		}
+
+		for(slot = 0; large[slot].header; slot++);
+		large[slot].header = (unsigned char *)header;
+		large[slot].length = length;
+		large_count++;
+		write(large[slot].header, (header_type)(length | 1));
+
+#if (DEBUG == HEAP_ADDRESS_DEBUG) || (DEBUG == HEAP_DEBUG_ALL)
+		printf("hmalloc :: Mapped large object %p[%zu]\n", header, length);
+#endif
+		return large[slot].header + HeaderWidth;
+	}
+
+	/**
+	 * large_unmap
+	 * ARGS:slot(slot of large object registry)
+	 * Return value: ret(OK,FAIL)
+	 * Description: Gives the mapping back to the kernel and clears its slot.
+	 */
+	bool_t large_unmap(int32_t slot) noexcept
+	{
+		bool_t ret = FAIL;
+
+		if(munmap(large[slot].header, large[slot].length) == 0)
+		{
+			ret = OK;
+		}
+		large[slot].header = nullptr;
+		large[slot].length = 0;
+		large_count--;
+
+		return ret;
+	}
+
+	/**
+	 * large_remap
+	 * ARGS:addr(address of buffer), size(new size), slot(slot of large object registry)
+	 * Return value: ret(OK,FAIL)
+	 * Description: Resizes a large object with mremap. The kernel moves page
+	 * table entries instead of the data, so growing never copies the buffer.
+	 * addr is updated when the mapping had to move.
+	 */
+	bool_t large_remap(void **addr, std::uint32_t size, int32_t slot) noexcept
+	{
+		size_t length = large_length(size);
+		void *header;
+
+		if(length > 0x7FFFFFFFUL)
+		{
+			return FAIL;
+		}
+
+		header = mremap(large[slot].header, large[slot].length, length, MREMAP_MAYMOVE);
+		if(header == MAP_FAILED)
+		{
+			return FAIL;
+		}
+
+		large[slot].header = (unsigned char *)header;
+		large[slot].length = length;
+		write(large[slot].header, (header_type)(length | 1));
+#if HEAP_PROFILER
+		HPROF_RESIZE_HOOK(*addr, large[slot].header + HeaderWidth, size);
+#endif
+		*addr = large[slot].header + HeaderWidth;
+		return OK;
+	}
+
+	/**
+	 * mem		: hheap memory, nullptr until init.
+	 * tracker	: block next fit starts searching from.
+	 * fresh_mark	: splits hheap memory in two, nothing at or above it has
+	 *            been written since init/flush, so those bytes are still
+	 *            the zero pages handed out by mmap.
+	 */
+	struct heap_memory *mem = nullptr;
+	unsigned char *tracker = nullptr;
+	unsigned char *fresh_mark = nullptr;
+	large_object large[HEAP_MMAP_SLOTS] = {};
+	std::uint32_t large_count = 0;
+	std::uint32_t mmap_threshold = HEAP_MMAP_THRESHOLD;
+	Policy policy;
+};
+
+/**
+ * Instantiation with the configuration of driver_beta from dma.h, policy
+ * is picked at runtime. dma.cpp defines the one instance behind HEAP.
+ */
+using beta_heap = basic_heap<HEAP_SIZE, ALIGNMENT, HEADER_SIZE, runtime_fit, exact_size>;
+
+extern beta_heap beta;
+
+} /* namespace hheap */
+
+#endif /* DYNAMIC_MEMORY_ALLOCATION_HHEAP_HPP_ */
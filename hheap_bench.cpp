@@ -0,0 +1,170 @@
+/*
+ * Copyright (c) 2022, Harsh Dave.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ *
+ */
+
+/**
+ * \file
+ *         Microbenchmark: per call cost of the dispatch driver_beta had
+ *         in C(HEAP.heap_alloc, then the find_fit function pointer)
+ *         against hheap::beta called through driver_beta and called
+ *         directly, plus basic_heaps whose policy is fixed at compile
+ *         time, with and without size classes.
+ *         Build with `make hheap_bench`, which compiles hheap with -DDEBUG=0.
+ * \author
+ *         Harsh Dave <HarshDave-Sithlord>
+ */
+
+#include <chrono>
+#include <cstdio>
+#include "hheap.hpp"
+
+/**
+ * Benchmark configuration.
+ * bench_calls	: allocations per round, small enough to stay far from
+ *                HEAP_SIZE.
+ * bench_rounds	: timed rounds per variant, best round is reported.
+ * bench_warm	: bytes written through one buffer before every round. Flush
+ *                hands pages back to the kernel, so without it the first
+ *                touch page faults would swamp the cost of dispatch.
+ */
+#define BENCH_CALLS 4096U
+#define BENCH_ROUNDS 200U
+#define BENCH_WARM (BENCH_CALLS * 80U)
+
+static unsigned int sizes[BENCH_CALLS];
+
+/**
+ * pointer_fit
+ * Dispatch of driver_beta in C: alloc reaches the search through a
+ * find_mem_block style function pointer, picked at runtime. It is
+ * volatile so that the compiler cannot see through it, just as dma.c
+ * could not see through its static find_fit.
+ */
+struct pointer_fit : hheap::fixed_policy<heap_next_fit>{
+	static inline unsigned char *(*volatile find_fit)(void *heap, std::uint32_t need);
+
+	template<class Heap>
+	unsigned char *find(Heap &heap, std::uint32_t need) noexcept
+	{
+		return find_fit(&heap, need);
+	}
+};
+
+using pointer_heap = hheap::basic_heap<HEAP_SIZE, ALIGNMENT, HEADER_SIZE, pointer_fit>;
+static pointer_heap pointed;
+
+static unsigned char *pointed_next_fit(void *heap, std::uint32_t need)
+{
+	hheap::no_probes probes;
+	return hheap::next_fit::search(*(pointer_heap *)heap, need, probes);
+}
+
+static void *pointed_alloc(unsigned int size)
+{
+	return pointed.alloc(size);
+}
+static hheap::basic_heap<HEAP_SIZE, ALIGNMENT, HEADER_SIZE, hheap::next_fit> fixed;
+static hheap::basic_heap<HEAP_SIZE, ALIGNMENT, HEADER_SIZE, hheap::next_fit, hheap::size_classes<>> classed;
+
+template<class Alloc, class Free, class Reset>
+static double bench(Alloc alloc, Free release, Reset reset)
+{
+	double best = 1e30;
+	std::uintptr_t sink = 0;
+	void *warm;
+
+	for(unsigned int round = 0; round < BENCH_ROUNDS; round++)
+	{
+		reset();
+		warm = alloc(BENCH_WARM);
+		memset(warm, 0, BENCH_WARM);
+		release(warm);
+		auto start = std::chrono::steady_clock::now();
+		for(unsigned int i = 0; i < BENCH_CALLS; i++)
+		{
+			sink ^= (std::uintptr_t)alloc(sizes[i]);
+		}
+		auto stop = std::chrono::steady_clock::now();
+		double ns = std::chrono::duration<double, std::nano>(stop - start).count() / BENCH_CALLS;
+		if(ns < best)
+		{
+			best = ns;
+		}
+	}
+
+	if(sink == 1)
+	{
+		printf("\n");
+	}
+	return best;
+}
+
+int main(void)
+{
+	for(unsigned int i = 0; i < BENCH_CALLS; i++)
+	{
+		sizes[i] = 1 + (i * 2654435761U) % 64;
+	}
+
+	pointer_fit::find_fit = pointed_next_fit;
+	void *(*volatile table_alloc)(unsigned int) = pointed_alloc;
+	if(pointed.init() != OK || HEAP.init_heap() != OK || fixed.init() != OK || classed.init() != OK)
+	{
+		printf("Failed!!\n");
+		return 1;
+	}
+
+	/**
+	 * Warm up buffer has to come out of hheap memory.
+	 */
+	HEAP.set_mmap_threshold(0);
+	pointed.set_mmap_threshold(0);
+	fixed.set_mmap_threshold(0);
+	classed.set_mmap_threshold(0);
+
+	double pointer = bench([&](unsigned int size) { return table_alloc(size); },
+			[](void *addr) { pointed.free(addr); }, []() { pointed.flush(); });
+	double table = bench([](unsigned int size) { return HEAP.heap_alloc(size); },
+			[](void *addr) { HEAP.heap_free(addr); }, []() { HEAP.heap_flush(); });
+	double direct = bench([](unsigned int size) { return hheap::beta.alloc(size); },
+			[](void *addr) { hheap::beta.free(addr); }, []() { hheap::beta.flush(); });
+	double inlined = bench([](unsigned int size) { return fixed.alloc(size); },
+			[](void *addr) { fixed.free(addr); }, []() { fixed.flush(); });
+	double rounded = bench([](unsigned int size) { return classed.alloc(size); },
+			[](void *addr) { classed.free(addr); }, []() { classed.flush(); });
+
+	printf("hheap_alloc, %u calls per round, best of %u rounds\n", BENCH_CALLS, BENCH_ROUNDS);
+	printf("table -> find_fit pointer(C driver_beta dispatch) : %6.2f ns/call\n", pointer);
+	printf("hheap::beta through driver_beta(HEAP.heap_alloc) : %6.2f ns/call\n", table);
+	printf("hheap::beta called directly                      : %6.2f ns/call\n", direct);
+	printf("basic_heap<.., next_fit> called directly         : %6.2f ns/call\n", inlined);
+	printf("basic_heap<.., next_fit, size_classes<>> directly: %6.2f ns/call\n", rounded);
+	return 0;
+}
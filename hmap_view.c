@@ -0,0 +1,225 @@
+/*
+ * Copyright (c) 2022, Harsh Dave.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ *
+ */
+
+/**
+ * \file
+ *         Offline viewer which renders heap maps written by hheap_export_map
+ * \author
+ *         Harsh Dave <HarshDave-Sithlord>
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "heap_map.h"
+
+/**
+ * Viewer configuration.
+ * map_cols	: cells per line of fragmentation map.
+ * map_rows	: lines of fragmentation map, every cell covers
+ *                heap_size / (map_cols * map_rows) bytes.
+ */
+#define MAP_COLS 64U
+#define MAP_ROWS 16U
+#define MAP_CELLS (MAP_COLS * MAP_ROWS)
+
+struct map_cell{
+	uint64_t used;
+	uint64_t free;
+	uint64_t corrupt;
+};
+
+struct map_summary{
+	uint64_t used_bytes;
+	uint64_t free_bytes;
+	uint64_t corrupt_bytes;
+	uint64_t mapped_bytes;
+	uint32_t mapped_objects;
+	uint32_t used_blocks;
+	uint32_t free_blocks;
+	uint32_t largest_free;
+	uint32_t records;
+};
+
+static struct map_cell cells[MAP_CELLS];
+
+/**
+ * map_span
+ * ARGS:offset, len(byte range), state, heap_size
+ * Return value: none
+ * Description: Charges the byte range to every map cell it overlaps.
+ */
+static void map_span(uint64_t offset, uint64_t len, uint8_t state, uint32_t heap_size)
+{
+	uint64_t cell_size = (heap_size + MAP_CELLS - 1) / MAP_CELLS;
+	uint64_t end = offset + len, cell_end, part;
+	uint32_t cell;
+
+	while(offset < end && offset < heap_size)
+	{
+		cell = offset / cell_size;
+		cell_end = (uint64_t)(cell + 1) * cell_size;
+		part = ((end < cell_end) ? end : cell_end) - offset;
+		if(state == HMAP_USED)
+			cells[cell].used += part;
+		else if(state == HMAP_FREE)
+			cells[cell].free += part;
+		else
+			cells[cell].corrupt += part;
+		offset += part;
+	}
+}
+
+/**
+ * map_show
+ * ARGS:summary, header of snapshot
+ * Return value: none
+ * Description: Prints fragmentation map and summary of one snapshot.
+ * '#' cell fully used, '.' fully free, '+' used and free mixed,
+ * '!' holds corrupt headers, ' ' not covered by any block.
+ */
+static void map_show(struct map_summary *summary, struct hmap_header *header)
+{
+	char line[MAP_COLS + 1];
+	uint32_t frag = 0;
+
+	printf("snapshot @ %lu.%09lu, heap %u bytes, %u records\n",
+			header->timestamp_ns / 1000000000UL, header->timestamp_ns % 1000000000UL,
+			header->heap_size, summary->records);
+	for(uint32_t row = 0; row < MAP_ROWS; row++)
+	{
+		for(uint32_t col = 0; col < MAP_COLS; col++)
+		{
+			struct map_cell *cell = &cells[row * MAP_COLS + col];
+			if(cell->corrupt)
+				line[col] = '!';
+			else if(cell->used && cell->free)
+				line[col] = '+';
+			else if(cell->used)
+				line[col] = '#';
+			else if(cell->free)
+				line[col] = '.';
+			else
+				line[col] = ' ';
+		}
+		line[MAP_COLS] = '\0';
+		printf("|%s|\n", line);
+	}
+
+	/**
+	 * Fragmentation: share of free memory which cannot be handed
+	 * out as one block.
+	 */
+	if(summary->free_bytes)
+	{
+		frag = (uint32_t)(100 - (summary->largest_free * 100UL) / summary->free_bytes);
+	}
+	printf("used    : %lu bytes in %u blocks\n", summary->used_bytes, summary->used_blocks);
+	printf("free    : %lu bytes in %u blocks, largest %u\n", summary->free_bytes, summary->free_blocks, summary->largest_free);
+	printf("corrupt : %lu bytes\n", summary->corrupt_bytes);
+	printf("mapped  : %lu bytes in %u large objects(outside heap)\n", summary->mapped_bytes, summary->mapped_objects);
+	printf("fragmentation : %u%%\n\n", frag);
+}
+
+int main(int argc, char *argv[])
+{
+	FILE *file = stdin;
+	struct hmap_header header;
+	struct hmap_record record;
+	struct map_summary summary;
+	int snapshots = 0;
+
+	if(argc > 1 && (file = fopen(argv[1], "rb")) == NULL)
+	{
+		perror(argv[1]);
+		return 1;
+	}
+
+	while(fread(&header, sizeof(header), 1, file) == 1)
+	{
+		if(memcmp(header.magic, HMAP_MAGIC, sizeof(header.magic)) != 0 ||
+				header.version != HMAP_VERSION || header.record_size != sizeof(struct hmap_record))
+		{
+			printf("Not a heap map(or unsupported version)\n");
+			return 1;
+		}
+
+		memset(cells, 0, sizeof(cells));
+		memset(&summary, 0, sizeof(summary));
+		while(1)
+		{
+			if(fread(&record, sizeof(record), 1, file) != 1)
+			{
+				printf("Truncated snapshot\n");
+				return 1;
+			}
+			if(record.state == HMAP_END)
+			{
+				break;
+			}
+
+			summary.records++;
+			if(record.state == HMAP_MAPPED)
+			{
+				summary.mapped_bytes += (uint64_t)record.size * record.run;
+				summary.mapped_objects += record.run;
+				continue;
+			}
+			map_span(record.offset, (uint64_t)record.size * record.run, record.state, header.heap_size);
+			if(record.state == HMAP_USED)
+			{
+				summary.used_bytes += (uint64_t)record.size * record.run;
+				summary.used_blocks += record.run;
+			}
+			else if(record.state == HMAP_FREE)
+			{
+				summary.free_bytes += (uint64_t)record.size * record.run;
+				summary.free_blocks += record.run;
+				if(record.size > summary.largest_free)
+				{
+					summary.largest_free = record.size;
+				}
+			}
+			else
+			{
+				summary.corrupt_bytes += (uint64_t)record.size * record.run;
+			}
+		}
+
+		map_show(&summary, &header);
+		snapshots++;
+	}
+
+	if(file != stdin)
+	{
+		fclose(file);
+	}
+	return snapshots ? 0 : 1;
+}
@@ -43,9 +43,11 @@
 #ifndef HHEAP_TYPEEDEFS
 typedef unsigned char bool_t;
 typedef unsigned char uint8_t;
+typedef unsigned short uint16_t;
 typedef unsigned int uint32_t;
 typedef int int32_t;
 typedef unsigned long uint64_t;
+typedef long int64_t;
 #endif /* HHEAP_TYPEEDEFS */
 
 